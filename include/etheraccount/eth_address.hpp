@@ -45,13 +45,17 @@ struct eth_address {
       return res;
    }
 
-   static eth_address from_bytes(const bytes& b) {
+   static eth_address from_bytes(const uint8_t* b, size_t size) {
       eth_address res;
-      check(b.empty() || res.data.size() == b.size(), "invalid size");
-      res.empty = b.empty();
+      check(size == 0 || res.data.size() == size, "invalid size");
+      res.empty = size == 0;
       if(!res.empty)
-         memcpy(res.data.data(), b.data(), b.size());
+         memcpy(res.data.data(), b, size);
       return res;
    }
 
+   static eth_address from_bytes(const bytes& b) {
+      return from_bytes(b.data(), b.size());
+   }
+
 };
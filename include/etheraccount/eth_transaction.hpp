@@ -13,7 +13,7 @@ struct eth_transaction {
     enum transaction_type : uint8_t {
         ETH_TRANSFER,
         ERC20_TRANSFER,
-        OTHER
+        PUSH_EOS_TRANSACTION
     };
 
     u256              nonce;
@@ -41,12 +41,16 @@ struct eth_transaction {
         return is_eth_transfer() || is_erc20_transfer();
     }
 
+    bool is_push_eos_transaction() {
+        return tx_type == transaction_type::PUSH_EOS_TRANSACTION;
+    }
+
     eth_address transfer_destination() {
         eosio::check(is_transfer(), "not a transfer");
         if( is_eth_transfer() ) {
             return to;
         }
-        return eth_address::from_bytes(bytes(data.data()+16, data.data()+16+20));
+        return eth_address::from_bytes(data.data()+16, 20);
     }
 
     asset get_fee() {
@@ -125,10 +129,19 @@ struct eth_transaction {
 
         if(!ethtx.data.size()) {
             ethtx.tx_type = transaction_type::ETH_TRANSFER;
-        } else if (ethtx.data.size() == 4+32+32 && *reinterpret_cast<uint32_t*>(ethtx.data.data()) == __builtin_bswap32(transfer_method_id)) {
-            ethtx.tx_type = transaction_type::ERC20_TRANSFER;
-        } else {
-            ethtx.tx_type = transaction_type::OTHER;
+            return ethtx;
+        }
+
+        switch( get_method_id(ethtx.data) ) {
+            case transfer_method_id:
+                eosio::check(ethtx.data.size() == 4+32+32, "invalid transfer call");
+                ethtx.tx_type = transaction_type::ERC20_TRANSFER;
+                break;
+            case push_eos_transaction_method_id:
+                ethtx.tx_type = transaction_type::PUSH_EOS_TRANSACTION;
+                break;
+            default:
+                eosio::check(false, "invalid method id");
         }
 
         return ethtx;
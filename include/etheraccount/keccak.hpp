@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace etheraccount { namespace keccak {
+
+// constexpr keccak-256 (original keccak padding, as used by ethereum).
+// Meant for compile time constants only, runtime hashing goes through sha3()
+
+namespace detail {
+
+static constexpr uint64_t round_constants[24] = {
+   0x0000000000000001, 0x0000000000008082, 0x800000000000808a, 0x8000000080008000,
+   0x000000000000808b, 0x0000000080000001, 0x8000000080008081, 0x8000000000008009,
+   0x000000000000008a, 0x0000000000000088, 0x0000000080008009, 0x000000008000000a,
+   0x000000008000808b, 0x800000000000008b, 0x8000000000008089, 0x8000000000008003,
+   0x8000000000008002, 0x8000000000000080, 0x000000000000800a, 0x800000008000000a,
+   0x8000000080008081, 0x8000000000008080, 0x0000000080000001, 0x8000000080008008
+};
+
+static constexpr int rotations[24] = {
+   1,  3,  6,  10, 15, 21, 28, 36, 45, 55, 2,  14,
+   27, 41, 56, 8,  25, 43, 62, 18, 39, 61, 20, 44
+};
+
+static constexpr int pi_lanes[24] = {
+   10, 7,  11, 17, 18, 3, 5,  16, 8,  21, 24, 4,
+   15, 23, 19, 13, 12, 2, 20, 14, 22, 9,  6,  1
+};
+
+static constexpr size_t rate = 136;
+
+constexpr uint64_t rotl( uint64_t x, int n ) {
+   return (x << n) | (x >> (64 - n));
+}
+
+constexpr void keccakf( uint64_t (&st)[25] ) {
+   for( int r = 0; r < 24; ++r ) {
+      // theta
+      uint64_t bc[5] = {};
+      for( int i = 0; i < 5; ++i )
+         bc[i] = st[i] ^ st[i+5] ^ st[i+10] ^ st[i+15] ^ st[i+20];
+      for( int i = 0; i < 5; ++i ) {
+         uint64_t t = bc[(i+4) % 5] ^ rotl(bc[(i+1) % 5], 1);
+         for( int j = 0; j < 25; j += 5 )
+            st[j+i] ^= t;
+      }
+
+      // rho, pi
+      uint64_t t = st[1];
+      for( int i = 0; i < 24; ++i ) {
+         int j = pi_lanes[i];
+         uint64_t tmp = st[j];
+         st[j] = rotl(t, rotations[i]);
+         t = tmp;
+      }
+
+      // chi
+      for( int j = 0; j < 25; j += 5 ) {
+         for( int i = 0; i < 5; ++i )
+            bc[i] = st[j+i];
+         for( int i = 0; i < 5; ++i )
+            st[j+i] ^= (~bc[(i+1) % 5]) & bc[(i+2) % 5];
+      }
+
+      // iota
+      st[0] ^= round_constants[r];
+   }
+}
+
+constexpr void absorb( uint64_t (&st)[25], size_t pos, uint8_t b ) {
+   st[pos / 8] ^= uint64_t(b) << (8 * (pos % 8));
+}
+
+} //namespace detail
+
+constexpr std::array<uint8_t, 32> keccak256( std::string_view data ) {
+   uint64_t st[25] = {};
+
+   size_t pos = 0;
+   for( char c : data ) {
+      detail::absorb(st, pos++, static_cast<uint8_t>(c));
+      if( pos == detail::rate ) {
+         detail::keccakf(st);
+         pos = 0;
+      }
+   }
+
+   detail::absorb(st, pos, 0x01);
+   detail::absorb(st, detail::rate - 1, 0x80);
+   detail::keccakf(st);
+
+   std::array<uint8_t, 32> res = {};
+   for( size_t i = 0; i < res.size(); ++i )
+      res[i] = static_cast<uint8_t>(st[i / 8] >> (8 * (i % 8)));
+   return res;
+}
+
+// 4-byte solidity selector of a canonical signature, e.g. "transfer(address,uint256)"
+constexpr uint32_t method_id( std::string_view signature ) {
+   auto h = keccak256(signature);
+   return (uint32_t(h[0]) << 24) | (uint32_t(h[1]) << 16) | (uint32_t(h[2]) << 8) | uint32_t(h[3]);
+}
+
+static_assert(keccak256("")[0] == 0xc5 && keccak256("")[31] == 0x70, "keccak256 self test failed");
+
+} //namespace keccak
+} //namespace etheraccount
@@ -7,15 +7,24 @@
 
 #include <etheraccount/config.hpp>
 #include <etheraccount/types.hpp>
+#include <etheraccount/keccak.hpp>
 #include <eosio.system/exchange_state.hpp>
 
 namespace etheraccount { namespace utils {
 
-// sha3(pushEosTransaction(uint64,bytes)) = bafbb2080991eb6180fc9765cedaa1f901f54801099bbd60be14a9c74b5c640c
-const uint32_t push_eos_transaction_method_id = 0xbafbb208;
+// ethereum entry points, selectors are computed at compile time from their signatures.
+// New entry points only need a constant here and a case in eth_transaction::from_rlp
+static constexpr uint32_t push_eos_transaction_method_id = keccak::method_id("pushEosTransaction(uint64,bytes)");
+static constexpr uint32_t transfer_method_id             = keccak::method_id("transfer(address,uint256)");
 
-// sha3(transfer(address,uint256)) = a9059cbb2ab09eb219583f4a59a5d0623ade346d962bcd4e46b11da047c9049b
-const uint32_t transfer_method_id = 0xa9059cbb;
+static_assert(push_eos_transaction_method_id == 0xbafbb208, "unexpected pushEosTransaction selector");
+static_assert(transfer_method_id == 0xa9059cbb, "unexpected transfer selector");
+
+// selector of an abi encoded call, read as big endian
+uint32_t get_method_id(const bytes& data) {
+   eosio::check(data.size() >= 4, "invalid method id");
+   return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | uint32_t(data[3]);
+}
 
 bytes32 sha3(const char* data, size_t len) {
    bytes32 message;
@@ -123,10 +123,9 @@ void etheraccount::pushtx( const bytes& rlptx, const asset& txfee, uint32_t ram2
          std::make_tuple( from_itr->eos_account, destination_eos_account, amount.quantity, std::string("") )
       ).send();
 
-   } else {
+   } else if( ethtx.is_push_eos_transaction() ) {
       auto payload = ethtx_payload::from_bytes(ethtx.data);
 
-      check(payload.method_id == __builtin_bswap32(push_eos_transaction_method_id), "invalid method id");
       check(static_cast<uint64_t>(payload.rp) == rp, "invalid rp");
 
       for(const auto& act : payload.actions) {
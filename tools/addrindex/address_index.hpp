@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/types.h>
+
+// Native (non-wasm) view of the contract's account_table, keyed by eth address.
+//
+// File layout (host byte order, little endian in practice):
+//
+//    header   64 bytes   { "ETHADDRX", version, layout, count, reserved }
+//    keys     32 bytes   { address[20], zero padding } * (count + 1)
+//    values   16 bytes   { eos_account (name value), nonce } * count
+//
+// Keys and values are kept apart so searches only touch keys, and both
+// blocks start on a 64 byte boundary. Key slot 0 is padding: record i is
+// slot i+1, which puts every pair of slots 2k, 2k+1 in one cache line.
+//
+// Records are either sorted by address (binary search) or stored in
+// Eytzinger (BFS) order, where the 8 descendants of a node three levels
+// down are 8 contiguous slots (4 aligned cache lines) prefetched while the
+// next levels are compared. address_index_bench measures both.
+
+namespace etheraccount { namespace addrindex {
+
+typedef std::array<uint8_t, 20> bytes20;
+
+static constexpr char     index_magic[8] = {'E','T','H','A','D','D','R','X'};
+static constexpr uint32_t index_version  = 2;
+static constexpr size_t   header_size    = 64;
+static constexpr size_t   key_size       = 32;
+static constexpr size_t   value_size     = 8 + 8;
+
+enum class layout : uint32_t {
+   sorted    = 0,
+   eytzinger = 1
+};
+
+struct entry {
+   bytes20  address;
+   uint64_t eos_account;
+   uint64_t nonce;
+
+   bool operator < ( const entry& o )const { return address < o.address; }
+};
+
+uint64_t    string_to_name( std::string_view s );
+std::string name_to_string( uint64_t value );
+
+uint64_t    uint64_from_string( std::string_view s );
+
+bytes20     address_from_string( std::string_view s );
+std::string address_to_string( const bytes20& address );
+
+class address_index;
+
+// Every record of an index, returned sorted by address
+std::vector<entry> read_index( const address_index& index );
+std::vector<entry> read_index( const std::string& path );
+
+// Sorts `entries`, rejects duplicated addresses and atomically replaces `path`
+// (write to a unique temporary file + rename) so mapped readers keep a valid snapshot
+void write_index( const std::string& path, std::vector<entry> entries, layout l );
+
+// Inserts or updates `updates` into `entries` (both sorted on return).
+// An address never changes its eos account; nonces only move forward.
+void merge_entries( std::vector<entry>& entries, std::vector<entry> updates );
+
+// Exclusive advisory lock (flock) serializing writers of the index at `path`,
+// hold it across a read_index / merge_entries / write_index cycle.
+// It is taken on "<path>.lock": write_index replaces the index file, so a lock
+// on the index itself would not be seen by a writer opening the new file
+class index_lock {
+   public:
+      explicit index_lock( const std::string& path );
+      ~index_lock();
+
+      index_lock( const index_lock& ) = delete;
+      index_lock& operator=( const index_lock& ) = delete;
+
+   private:
+      int fd = -1;
+};
+
+// Read only mapping of one snapshot of the index.
+//
+// write_index replaces the file instead of modifying it, so a long lived
+// reader keeps serving the snapshot it mapped. Poll is_current() (one stat)
+// and call reload() when it returns false, e.g. before each batch of lookups:
+//
+//    if( !index.is_current() ) index.reload();
+//
+// reload() remaps in place, so it must not race with find() from other
+// threads; those callers should build a fresh address_index instead and
+// swap it in (the class is movable) under their own synchronization.
+class address_index {
+   public:
+      explicit address_index( const std::string& path );
+      ~address_index();
+
+      address_index( address_index&& o ) noexcept { swap(o); }
+      address_index& operator=( address_index&& o ) noexcept { swap(o); return *this; }
+
+      address_index( const address_index& ) = delete;
+      address_index& operator=( const address_index& ) = delete;
+
+      bool find( const bytes20& address, entry& out )const;
+
+      // i-th record in file order (see get_layout)
+      entry at( size_t i )const;
+
+      size_t     size()const        { return count; }
+      layout     get_layout()const  { return index_layout; }
+
+      // false once the file at the mapped path was replaced (or removed)
+      bool is_current()const;
+
+      // maps the file currently at the path if it changed, returns whether
+      // it did. On error the previous snapshot is kept and the error thrown
+      bool reload();
+
+      void swap( address_index& o ) noexcept;
+
+   private:
+      // 1-based key slot, record i is slot i+1
+      const uint8_t* key( size_t slot )const { return keys + slot * key_size; }
+      void           load( size_t i, entry& out )const;
+
+      size_t find_sorted( const uint8_t* key )const;
+      size_t find_eytzinger( const uint8_t* key )const;
+
+      std::string    path;
+      dev_t          device     = 0;
+      ino_t          inode      = 0;
+      void*          map        = nullptr;
+      size_t         map_size   = 0;
+      const uint8_t* keys       = nullptr;
+      const uint8_t* values     = nullptr;
+      size_t         count      = 0;
+      layout         index_layout = layout::sorted;
+};
+
+} //namespace addrindex
+} //namespace etheraccount
@@ -0,0 +1,103 @@
+// address_index_bench: lookup cost of address_index::find for both layouts.
+//
+//    address_index_bench [entries...]        (default: 100000 2000000)
+//
+// For every size it writes a random index to a temporary file and measures
+// one million random hits twice: independent lookups (throughput, the CPU
+// may overlap them) and a dependent chain where each query waits on the
+// previous result (latency, what a relayer pays per incoming transaction).
+
+#include <address_index.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace etheraccount::addrindex;
+
+namespace {
+
+static constexpr size_t lookups = 1000000;
+
+std::vector<entry> random_entries( size_t n, std::mt19937_64& rng ) {
+   std::vector<entry> res(n);
+   for( auto& e : res ) {
+      for( auto& b : e.address ) b = rng();
+      e.eos_account = rng();
+      e.nonce       = rng();
+   }
+   return res;
+}
+
+double ns_per_lookup( std::chrono::steady_clock::duration d ) {
+   return std::chrono::duration<double, std::nano>(d).count() / lookups;
+}
+
+void run( size_t n, layout l, const std::vector<entry>& entries, const std::vector<bytes20>& queries, uint64_t zero ) {
+   char path[] = "/tmp/address_index_bench.XXXXXX";
+   int fd = mkstemp(path);
+   if( fd < 0 ) throw std::runtime_error("unable to create temporary file");
+   ::close(fd);
+
+   write_index(path, entries, l);
+   address_index index(path);
+   unlink(path);
+
+   entry e;
+   size_t found = 0;
+
+   auto start = std::chrono::steady_clock::now();
+   for( const auto& q : queries )
+      found += index.find(q, e);
+   auto throughput = std::chrono::steady_clock::now() - start;
+
+   // `zero` is 0 at runtime but unknown to the compiler, chaining every
+   // query to the nonce returned by the previous lookup
+   uint64_t prev = 0;
+   start = std::chrono::steady_clock::now();
+   for( const auto& q : queries ) {
+      auto key = q;
+      key[0] ^= static_cast<uint8_t>(prev & zero);
+      found += index.find(key, e);
+      prev = e.nonce;
+   }
+   auto latency = std::chrono::steady_clock::now() - start;
+
+   if( found != 2 * queries.size() )
+      throw std::runtime_error("lookup missed an existing address");
+
+   printf("%10zu  %-9s  %8.1f ns/lookup  %8.1f ns/dependent lookup\n", n,
+          l == layout::sorted ? "sorted" : "eytzinger", ns_per_lookup(throughput), ns_per_lookup(latency));
+}
+
+} //namespace
+
+int main( int argc, char** argv ) {
+   std::vector<size_t> sizes;
+   for( int i = 1; i < argc; ++i )
+      sizes.push_back(strtoull(argv[i], nullptr, 10));
+   if( sizes.empty() )
+      sizes = {100000, 2000000};
+
+   try {
+      std::mt19937_64 rng(42);
+      for( auto n : sizes ) {
+         if( !n ) throw std::runtime_error("invalid size");
+         auto entries = random_entries(n, rng);
+
+         std::vector<bytes20> queries(lookups);
+         for( auto& q : queries )
+            q = entries[rng() % n].address;
+
+         for( auto l : {layout::sorted, layout::eytzinger} )
+            run(n, l, entries, queries, argc > 1000 ? ~0ull : 0);
+      }
+   } catch( const std::exception& e ) {
+      fprintf(stderr, "error: %s\n", e.what());
+      return 1;
+   }
+   return 0;
+}
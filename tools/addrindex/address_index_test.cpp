@@ -0,0 +1,240 @@
+// address_index_test: round trips write_index / address_index for both
+// layouts and checks the merge_entries rules. Exits non zero on failure.
+
+#include <address_index.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace etheraccount::addrindex;
+
+namespace {
+
+int failures = 0;
+
+void check( bool cond, const std::string& what ) {
+   if( !cond ) {
+      fprintf(stderr, "FAILED: %s\n", what.c_str());
+      ++failures;
+   }
+}
+
+template<typename F>
+void check_throws( F f, const std::string& what ) {
+   try {
+      f();
+   } catch( const std::runtime_error& ) {
+      return;
+   }
+   check(false, what + " did not throw");
+}
+
+entry make_entry( const bytes20& address, uint64_t account, uint64_t nonce ) {
+   entry e;
+   e.address     = address;
+   e.eos_account = account;
+   e.nonce       = nonce;
+   return e;
+}
+
+bytes20 random_address( std::mt19937_64& rng ) {
+   bytes20 a;
+   for( auto& b : a ) b = rng();
+   return a;
+}
+
+std::string tmp_dir;
+
+std::string tmp_path( const std::string& name ) {
+   return tmp_dir + "/" + name;
+}
+
+const char* layout_name( layout l ) {
+   return l == layout::sorted ? "sorted" : "eytzinger";
+}
+
+// every entry is found with its values, read_index gives them back sorted
+void check_round_trip( const std::vector<entry>& entries, const std::vector<bytes20>& misses, layout l, const std::string& what ) {
+   auto path = tmp_path("round_trip.idx");
+   write_index(path, entries, l);
+
+   address_index index(path);
+   auto ctx = what + " (" + layout_name(l) + ", " + std::to_string(entries.size()) + " entries)";
+   check(index.size() == entries.size(), "size " + ctx);
+   check(index.get_layout() == l, "layout " + ctx);
+
+   for( const auto& e : entries ) {
+      entry out;
+      bool found = index.find(e.address, out);
+      check(found, "hit " + address_to_string(e.address) + " " + ctx);
+      if( found )
+         check(out.address == e.address && out.eos_account == e.eos_account && out.nonce == e.nonce,
+               "values of " + address_to_string(e.address) + " " + ctx);
+   }
+
+   for( const auto& m : misses ) {
+      entry out;
+      check(!index.find(m, out), "miss " + address_to_string(m) + " " + ctx);
+   }
+
+   auto sorted = entries;
+   std::sort(sorted.begin(), sorted.end());
+   auto read = read_index(index);
+   bool same = read.size() == sorted.size();
+   for( size_t i = 0; same && i < read.size(); ++i )
+      same = read[i].address == sorted[i].address && read[i].eos_account == sorted[i].eos_account &&
+             read[i].nonce == sorted[i].nonce;
+   check(same, "read_index " + ctx);
+}
+
+void test_round_trip() {
+   std::mt19937_64 rng(7);
+
+   for( size_t n = 0; n <= 300; ++n ) {
+      std::vector<entry> entries;
+      std::vector<bytes20> present;
+      while( entries.size() < n ) {
+         auto a = random_address(rng);
+         if( std::find(present.begin(), present.end(), a) != present.end() ) continue;
+         present.push_back(a);
+         entries.push_back(make_entry(a, rng(), rng()));
+      }
+
+      // below, above and right next to existing keys
+      std::vector<bytes20> misses;
+      bytes20 lo, hi;
+      lo.fill(0x00);
+      hi.fill(0xff);
+      misses.push_back(lo);
+      misses.push_back(hi);
+      for( size_t i = 0; i < 20; ++i )
+         misses.push_back(random_address(rng));
+      for( const auto& a : present ) {
+         auto b = a;
+         b[19] ^= 1;
+         misses.push_back(b);
+      }
+      misses.erase(std::remove_if(misses.begin(), misses.end(), [&](const auto& m){
+         return std::find(present.begin(), present.end(), m) != present.end();
+      }), misses.end());
+
+      for( auto l : {layout::sorted, layout::eytzinger} )
+         check_round_trip(entries, misses, l, "random");
+   }
+}
+
+// keys sharing their first 8 or 16 bytes exercise every word of the compare
+void test_shared_prefixes() {
+   std::vector<entry> entries;
+   std::vector<bytes20> misses;
+   for( int i = 0; i < 64; ++i ) {
+      bytes20 a;
+      a.fill(0x42);
+      a[i % 2 ? 19 : 12] = static_cast<uint8_t>(2 * i);
+      entries.push_back(make_entry(a, i, i));
+
+      auto m = a;
+      m[i % 2 ? 19 : 12] = static_cast<uint8_t>(2 * i + 1);
+      misses.push_back(m);
+   }
+   std::sort(entries.begin(), entries.end());
+   entries.erase(std::unique(entries.begin(), entries.end(), [](const auto& a, const auto& b){
+      return a.address == b.address;
+   }), entries.end());
+
+   for( auto l : {layout::sorted, layout::eytzinger} )
+      check_round_trip(entries, misses, l, "shared prefixes");
+}
+
+void test_merge() {
+   bytes20 a, b, c;
+   a.fill(0x10);
+   b.fill(0x20);
+   c.fill(0x30);
+
+   std::vector<entry> entries = { make_entry(b, 2, 5), make_entry(a, 1, 3) };
+
+   // highest nonce wins, within the batch and against the index
+   merge_entries(entries, { make_entry(a, 1, 7), make_entry(a, 1, 4), make_entry(b, 2, 1), make_entry(c, 3, 0) });
+   check(entries.size() == 3, "merge adds new addresses");
+   check(std::is_sorted(entries.begin(), entries.end()), "merge keeps entries sorted");
+   check(entries[0].address == a && entries[0].nonce == 7, "merge takes highest nonce of the batch");
+   check(entries[1].address == b && entries[1].nonce == 5, "merge never lowers a nonce");
+   check(entries[2].address == c && entries[2].eos_account == 3 && entries[2].nonce == 0, "merge inserts new entry");
+
+   check_throws([&]{ merge_entries(entries, { make_entry(a, 9, 8) }); }, "conflicting account against the index");
+   check_throws([&]{ auto copy = entries; merge_entries(copy, { make_entry(c, 3, 1), make_entry(c, 4, 2) }); },
+                "conflicting accounts within a batch");
+   check(entries[0].nonce == 7, "failed merge leaves existing nonces");
+}
+
+void test_invalid() {
+   bytes20 a;
+   a.fill(0x01);
+   auto path = tmp_path("invalid.idx");
+
+   check_throws([&]{ write_index(path, { make_entry(a, 1, 1), make_entry(a, 2, 2) }, layout::sorted); },
+                "duplicated address");
+
+   write_index(path, { make_entry(a, 1, 1) }, layout::eytzinger);
+   check(truncate(path.c_str(), header_size + 8) == 0, "truncate index");
+   check_throws([&]{ address_index index(path); }, "truncated index");
+   check_throws([&]{ address_index index(tmp_path("missing.idx")); }, "missing index");
+}
+
+void test_reload() {
+   bytes20 a;
+   a.fill(0x05);
+   auto path = tmp_path("reload.idx");
+
+   write_index(path, { make_entry(a, 1, 1) }, layout::sorted);
+   address_index index(path);
+   check(index.is_current() && !index.reload(), "fresh index is current");
+
+   write_index(path, { make_entry(a, 1, 2) }, layout::eytzinger);
+   entry out;
+   check(index.find(a, out) && out.nonce == 1, "old snapshot kept until reload");
+   check(!index.is_current(), "replaced index is not current");
+   check(index.reload() && index.is_current(), "reload maps the new file");
+   check(index.find(a, out) && out.nonce == 2 && index.get_layout() == layout::eytzinger, "reloaded values");
+
+   address_index moved(std::move(index));
+   check(moved.find(a, out) && out.nonce == 2, "moved index");
+}
+
+} //namespace
+
+int main() {
+   char dir[] = "/tmp/address_index_test.XXXXXX";
+   if( !mkdtemp(dir) ) {
+      fprintf(stderr, "unable to create temporary directory\n");
+      return 1;
+   }
+   tmp_dir = dir;
+
+   try {
+      test_round_trip();
+      test_shared_prefixes();
+      test_merge();
+      test_invalid();
+      test_reload();
+   } catch( const std::exception& e ) {
+      fprintf(stderr, "FAILED: unexpected error: %s\n", e.what());
+      ++failures;
+   }
+
+   for( auto name : {"round_trip.idx", "invalid.idx", "reload.idx"} )
+      unlink(tmp_path(name).c_str());
+   rmdir(dir);
+
+   if( failures ) {
+      fprintf(stderr, "%d check(s) failed\n", failures);
+      return 1;
+   }
+   printf("all checks passed\n");
+   return 0;
+}
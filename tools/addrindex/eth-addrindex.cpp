@@ -0,0 +1,275 @@
+// eth-addrindex: builds and queries the address index read by address_index.
+//
+//    eth-addrindex build  <page.json>... <index> [--eytzinger]
+//    eth-addrindex update <index> <rows.json|-> [--sorted|--eytzinger]
+//    eth-addrindex lookup <index> <address>...
+//    eth-addrindex dump   <index>
+//
+// `build` takes a dump of account_table as printed by `cleos get table`.
+// nodeos returns one page at a time and may cut a page short on its time
+// limit whatever `-l` asks for, so pass every page, fetching the next one
+// with `-L <next_key>` of the previous until `"more": false` (cleos takes
+// the limit as unsigned, use an explicit large value rather than -1):
+//
+//    cleos get table <contract> <contract> account -l 100000 > page0.json
+//    cleos get table <contract> <contract> account -l 100000 -L <next_key> > page1.json
+//
+// The build fails if the last page still reports more rows. `update` takes any
+// JSON carrying account rows ({"eos_account","eth_address","nonce"}) at any
+// depth, e.g. table deltas or traces of the contract filtered by a relayer,
+// and upserts them keeping the highest nonce seen for every address.
+// Writers serialize on "<index>.lock", so concurrent updates never lose rows.
+
+#include <address_index.hpp>
+
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+using namespace etheraccount::addrindex;
+
+namespace {
+
+// Minimal JSON walker: collects every object holding an account row
+class row_scanner {
+   public:
+      explicit row_scanner( std::string_view s ) : str(s) {}
+
+      std::vector<entry> scan() {
+         std::vector<entry> rows;
+         skip_ws();
+         value(rows, nullptr);
+         skip_ws();
+         if( pos != str.size() )
+            fail("trailing characters");
+         return rows;
+      }
+
+      // paging fields of a `get table` result ("more", "next_key")
+      bool               more()const     { return has_more; }
+      const std::string& next_key()const { return next; }
+
+   private:
+      std::string_view str;
+      size_t           pos      = 0;
+      size_t           depth    = 0;
+      bool             has_more = false;
+      std::string      next;
+
+      [[noreturn]] void fail( const char* what ) {
+         throw std::runtime_error(std::string("invalid json (") + what + ") at offset " + std::to_string(pos));
+      }
+
+      void skip_ws() {
+         while( pos < str.size() && isspace(static_cast<unsigned char>(str[pos])) ) ++pos;
+      }
+
+      void expect( char c ) {
+         skip_ws();
+         if( pos >= str.size() || str[pos] != c ) fail("unexpected character");
+         ++pos;
+      }
+
+      std::string string() {
+         expect('"');
+         std::string res;
+         while( pos < str.size() && str[pos] != '"' ) {
+            if( str[pos] == '\\' ) {
+               // row fields never need escapes; keep the escaped char as is
+               if( ++pos >= str.size() ) break;
+            }
+            res += str[pos++];
+         }
+         expect('"');
+         return res;
+      }
+
+      // scalars are returned as text, containers are walked recursively
+      void value( std::vector<entry>& rows, std::string* scalar ) {
+         skip_ws();
+         if( pos >= str.size() ) fail("unexpected end");
+
+         char c = str[pos];
+         if( c == '{' ) {
+            object(rows);
+         } else if( c == '[' ) {
+            ++pos;
+            skip_ws();
+            if( pos < str.size() && str[pos] == ']' ) { ++pos; return; }
+            do { value(rows, nullptr); skip_ws(); } while( pos < str.size() && str[pos] == ',' && ++pos );
+            expect(']');
+         } else if( c == '"' ) {
+            auto s = string();
+            if( scalar ) *scalar = std::move(s);
+         } else {
+            auto start = pos;
+            while( pos < str.size() && !strchr(",]} \t\r\n", str[pos]) ) ++pos;
+            if( start == pos ) fail("empty value");
+            if( scalar ) *scalar = std::string(str.substr(start, pos - start));
+         }
+      }
+
+      // converts a row field, errors name the field and where the row starts
+      template<typename Parser>
+      static auto field( const std::pair<const std::string, std::string>& f, size_t offset, Parser parse ) {
+         try {
+            return parse(f.second);
+         } catch( const std::exception& e ) {
+            throw std::runtime_error("invalid " + f.first + " \"" + f.second + "\" in row at offset " +
+                                     std::to_string(offset) + " (" + e.what() + ")");
+         }
+      }
+
+      void object( std::vector<entry>& rows ) {
+         skip_ws();
+         auto start = pos;
+         expect('{');
+         std::map<std::string, std::string> fields;
+         skip_ws();
+         if( pos < str.size() && str[pos] == '}' ) { ++pos; return; }
+         ++depth;
+         do {
+            auto key = string();
+            expect(':');
+            std::string scalar;
+            value(rows, &scalar);
+            fields[key] = std::move(scalar);
+            skip_ws();
+         } while( pos < str.size() && str[pos] == ',' && ++pos );
+         expect('}');
+         --depth;
+
+         if( depth == 0 ) {
+            has_more = fields["more"] == "true";
+            next     = fields["next_key"];
+         }
+
+         auto account = fields.find("eos_account");
+         auto address = fields.find("eth_address");
+         auto nonce   = fields.find("nonce");
+         if( account == fields.end() || address == fields.end() || nonce == fields.end() )
+            return;
+
+         entry e;
+         e.address     = field(*address, start, address_from_string);
+         e.eos_account = field(*account, start, string_to_name);
+         e.nonce       = field(*nonce, start, uint64_from_string);
+         rows.push_back(e);
+      }
+};
+
+std::string read_all( const std::string& path ) {
+   std::stringstream ss;
+   if( path == "-" ) {
+      ss << std::cin.rdbuf();
+   } else {
+      std::ifstream f(path, std::ios::binary);
+      if( !f )
+         throw std::runtime_error("unable to open " + path);
+      ss << f.rdbuf();
+   }
+   return ss.str();
+}
+
+layout layout_flag( const std::string& flag, layout def ) {
+   if( flag.empty() )         return def;
+   if( flag == "--sorted" )    return layout::sorted;
+   if( flag == "--eytzinger" ) return layout::eytzinger;
+   throw std::runtime_error("unknown option " + flag);
+}
+
+void print_entry( const entry& e ) {
+   std::cout << address_to_string(e.address) << " "
+             << name_to_string(e.eos_account) << " "
+             << e.nonce << "\n";
+}
+
+int usage() {
+   std::cerr << "usage:\n"
+             << "   eth-addrindex build  <page.json>... <index> [--eytzinger]\n"
+             << "   eth-addrindex update <index> <rows.json|-> [--sorted|--eytzinger]\n"
+             << "   eth-addrindex lookup <index> <address>...\n"
+             << "   eth-addrindex dump   <index>\n"
+             << "pages for build: cleos get table <contract> <contract> account -l 100000 [-L <next_key>]\n"
+             << "repeated with the previous page's next_key until \"more\" is false\n";
+   return 1;
+}
+
+} //namespace
+
+int main( int argc, char** argv ) {
+   std::vector<std::string> args(argv + 1, argv + argc);
+   if( args.empty() ) return usage();
+
+   try {
+      const auto& cmd = args[0];
+
+      if( cmd == "build" && args.size() >= 3 ) {
+         std::string flag;
+         if( args.back().find("--") == 0 ) {
+            flag = args.back();
+            args.pop_back();
+         }
+         auto l = layout_flag(flag, layout::sorted);
+         if( args.size() < 3 ) return usage();
+
+         const auto& path = args.back();
+         std::vector<entry> rows;
+         for( size_t i = 1; i + 1 < args.size(); ++i ) {
+            auto text = read_all(args[i]);
+            row_scanner scanner(text);
+            auto page = scanner.scan();
+            rows.insert(rows.end(), page.begin(), page.end());
+
+            if( i + 2 == args.size() && scanner.more() )
+               throw std::runtime_error("incomplete dump, " + args[i] + " reports more rows; fetch the next page with -L " +
+                                        scanner.next_key() + " and pass it too");
+         }
+
+         index_lock lock(path);
+         write_index(path, rows, l);
+         std::cerr << rows.size() << " accounts written to " << path << "\n";
+
+      } else if( cmd == "update" && (args.size() == 3 || args.size() == 4) ) {
+         index_lock lock(args[1]);
+
+         address_index index(args[1]);
+         auto entries = read_index(index);
+         auto updates = row_scanner(read_all(args[2])).scan();
+         merge_entries(entries, updates);
+         write_index(args[1], entries, layout_flag(args.size() == 4 ? args[3] : "", index.get_layout()));
+         std::cerr << updates.size() << " rows applied, " << entries.size() << " accounts in " << args[1] << "\n";
+
+      } else if( cmd == "lookup" && args.size() >= 3 ) {
+         address_index index(args[1]);
+         int missing = 0;
+         for( size_t i = 2; i < args.size(); ++i ) {
+            auto address = address_from_string(args[i]);
+
+            entry e;
+            if( index.find(address, e) ) {
+               print_entry(e);
+            } else {
+               std::cout << address_to_string(address) << " not found\n";
+               ++missing;
+            }
+         }
+         return missing ? 2 : 0;
+
+      } else if( cmd == "dump" && args.size() == 2 ) {
+         for( const auto& e : read_index(args[1]) )
+            print_entry(e);
+
+      } else {
+         return usage();
+      }
+   } catch( const std::exception& e ) {
+      std::cerr << "error: " << e.what() << "\n";
+      return 1;
+   }
+
+   return 0;
+}